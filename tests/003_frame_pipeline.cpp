@@ -0,0 +1,297 @@
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <SDL.h>
+#include <glad/glad.h>
+#include <tgl/context.hpp>
+#include <tgl/render_target.hpp>
+#include <tgl/blending.hpp>
+#include <glm/vec3.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/euler_angles.hpp>
+#include <tgl/mesh.hpp>
+#include <tgl/shader.hpp>
+#include <tl/colors.hpp>
+#include "frame_pipeline.hpp"
+
+// Simulation and input run on the main thread, GL submission runs on a render thread that owns the context
+// The threads hand off through lock-free triple buffers, so neither of them blocks on the other
+// The camera is latched as late as possible: right before the draw call that uses it
+// Press 1, 2 or 3 to change the number of frames in flight. Drag or scroll to move the camera: the latency stats
+// measure from the moment an input event is read to the first frame that shows it
+
+static SDL_Window* window = nullptr;
+static SDL_GLContext glContext;
+static std::atomic<bool> gameLoopRunning = {true};
+static std::atomic<int> framesInFlight = {2};
+
+static const char vertShaderSrc[] = R"GLSL(
+#version 330
+
+layout(location = 0) in vec3 a_pos;
+layout(location = 1) in vec3 a_color;
+
+out vec3 color;
+
+uniform mat4 u_modelViewProj;
+
+void main()
+{
+    color = a_color;
+    gl_Position = u_modelViewProj * vec4(a_pos, 1.0);
+}
+)GLSL";
+
+static const char fragShaderSrc[] = R"GLSL(
+#version 330
+
+layout(location = 0) out vec4 o_color;
+
+in vec3 color;
+
+void main()
+{
+    o_color = vec4(color, 1.0);
+}
+)GLSL";
+
+constexpr int numVerts = 36;
+static const glm::vec3 trianglePositions[numVerts] = {
+    // FRONT
+    {-0.5f, -0.5f, +0.5f}, {+0.5f, -0.5f, +0.5f}, {+0.5f, +0.5f, +0.5f},
+    {-0.5f, -0.5f, +0.5f}, {+0.5f, +0.5f, +0.5f}, {-0.5f, +0.5f, +0.5f},
+    // BACK
+    {-0.5f, -0.5f, -0.5f}, {+0.5f, +0.5f, -0.5f}, {+0.5f, -0.5f, -0.5f},
+    {-0.5f, -0.5f, -0.5f}, {-0.5f, +0.5f, -0.5f}, {+0.5f, +0.5f, -0.5f},
+    // LEFT
+    {-0.5f, -0.5f, -0.5f}, {-0.5f, -0.5f, +0.5f}, {-0.5f, +0.5f, +0.5f},
+    {-0.5f, -0.5f, -0.5f}, {-0.5f, +0.5f, +0.5f}, {-0.5f, +0.5f, -0.5f},
+    // RIGHT
+    {+0.5f, -0.5f, -0.5f}, {+0.5f, +0.5f, +0.5f}, {+0.5f, -0.5f, +0.5f},
+    {+0.5f, -0.5f, -0.5f}, {+0.5f, +0.5f, -0.5f}, {+0.5f, +0.5f, +0.5f},
+    // TOP
+    {-0.5f, +0.5f, +0.5f}, {+0.5f, +0.5f, +0.5f}, {+0.5f, +0.5f, -0.5f},
+    {-0.5f, +0.5f, +0.5f}, {+0.5f, +0.5f, -0.5f}, {-0.5f, +0.5f, -0.5f},
+    // DOWN
+    {-0.5f, -0.5f, +0.5f}, {+0.5f, -0.5f, -0.5f}, {+0.5f, -0.5f, +0.5f},
+    {-0.5f, -0.5f, +0.5f}, {-0.5f, -0.5f, -0.5f}, {+0.5f, -0.5f, -0.5f},
+};
+static const glm::vec3 triangleColors[numVerts] = {
+    // FRONT
+    tl::colors::red(), tl::colors::red(), tl::colors::red(),
+    tl::colors::red(), tl::colors::red(), tl::colors::red(),
+    // BACK
+    tl::colors::green(), tl::colors::green(), tl::colors::green(),
+    tl::colors::green(), tl::colors::green(), tl::colors::green(),
+    // LEFT
+    tl::colors::blue(), tl::colors::blue(), tl::colors::blue(),
+    tl::colors::blue(), tl::colors::blue(), tl::colors::blue(),
+    // RIGHT
+    tl::colors::yellow(), tl::colors::yellow(), tl::colors::yellow(),
+    tl::colors::yellow(), tl::colors::yellow(), tl::colors::yellow(),
+    // TOP
+    tl::colors::cyan(), tl::colors::cyan(), tl::colors::cyan(),
+    tl::colors::cyan(), tl::colors::cyan(), tl::colors::cyan(),
+    // DOWN
+    tl::colors::magenta(), tl::colors::magenta(), tl::colors::magenta(),
+    tl::colors::magenta(), tl::colors::magenta(), tl::colors::magenta(),
+};
+
+constexpr int INIT_WINDOW_WIDTH = 800;
+constexpr int INIT_WINDOW_HEIGHT = 600;
+
+// produced by the simulation, once per simulation step
+struct FramePacket
+{
+    glm::mat4 modelMtx;
+    i32 windowW, windowH;
+};
+
+// produced every time the input is sampled
+struct CameraLatch
+{
+    glm::mat4 rotation;
+    float distance;
+    // when the last input event that moved the camera was read, 0 if there hasn't been any yet
+    Uint64 inputTimestamp;
+};
+
+static tw::TripleBuffer<FramePacket> framePackets;
+static tw::TripleBuffer<CameraLatch> cameraLatches;
+
+static void renderThreadFn()
+{
+    SDL_GL_MakeCurrent(window, glContext);
+    SDL_GL_SetSwapInterval(1); // Enable vsync
+
+    if(gladLoadGL() == 0) {
+        fprintf(stderr, "Failed to initialize OpenGL loader!\n");
+        gameLoopRunning = false;
+        return;
+    }
+    tgl::enableDepthTest(true);
+    tgl::blending::enable();
+
+    auto vboPos = tgl::VboT<glm::vec3>::create();
+    auto vboColor = tgl::VboT<glm::vec3>::create();
+    auto vao = tgl::Vao::create();
+    vboPos.upload(trianglePositions);
+    vboColor.upload(triangleColors);
+    vao.link(0, vboPos.attribRef<0>());
+    vao.link(1, vboColor.attribRef<0>());
+
+    auto shader = tgl::ShaderProgram::create(vertShaderSrc, fragShaderSrc);
+
+    tw::FrameFences fences;
+    tw::LatencyStats swapStats("input->swap");
+    tw::LatencyStats gpuStats("input->gpu done (upper bound)");
+    i32 viewportW = 0, viewportH = 0;
+    Uint64 lastSampledInput = 0;
+    while(gameLoopRunning)
+    {
+        // don't let the GPU queue up more frames than requested
+        const Uint64 retiredTimestamp = fences.waitForSlot(framesInFlight);
+        if(retiredTimestamp)
+            gpuStats.addSample(tw::secondsSince(retiredTimestamp));
+
+        framePackets.fetch();
+        const FramePacket& packet = framePackets.readSlot();
+        if(packet.windowW != viewportW || packet.windowH != viewportH) {
+            viewportW = packet.windowW;
+            viewportH = packet.windowH;
+            tgl::viewport(0, 0, viewportW, viewportH);
+            tgl::scissor(0, 0, viewportW, viewportH);
+        }
+
+        shader.use();
+        tgl::clear({0, 0.1f, 0.1f, 0.f});
+
+        // late latch: grab the most recent camera just before submitting the draw
+        cameraLatches.fetch();
+        const CameraLatch camera = cameraLatches.readSlot();
+        const auto projMtx = glm::perspective(glm::radians(60.f), (float)viewportW / viewportH, 0.1f, 100.f);
+        const auto viewMtx = glm::translate(glm::mat4(1), {0, 0, -camera.distance}) * camera.rotation;
+        const auto modelViewProj = projMtx * viewMtx * packet.modelMtx;
+        shader.set("u_modelViewProj", modelViewProj);
+        tgl::drawArrays(vao, tgl::Primitive::TRIANGLES, numVerts);
+
+        SDL_GL_SwapWindow(window);
+        // only the first frame that shows a new input event counts as a latency sample
+        const bool newInput = camera.inputTimestamp != lastSampledInput;
+        if(newInput) {
+            lastSampledInput = camera.inputTimestamp;
+            swapStats.addSample(tw::secondsSince(camera.inputTimestamp));
+        }
+        fences.insert(newInput ? camera.inputTimestamp : 0);
+    }
+
+    fences.waitAll();
+    shader.free();
+    vboPos.free();
+    vboColor.free();
+    vao.free();
+    SDL_GL_MakeCurrent(window, nullptr);
+}
+
+void launch_test_3()
+{
+    if(SDL_Init(SDL_INIT_EVERYTHING) != 0) {
+        fprintf(stderr, "Error: %s\n", SDL_GetError());
+        return;
+    }
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+
+    window = SDL_CreateWindow("title",
+        SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+        INIT_WINDOW_WIDTH, INIT_WINDOW_HEIGHT,
+        SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE
+    );
+    // the context is created here but it will be owned by the render thread
+    glContext = SDL_GL_CreateContext(window);
+    SDL_GL_MakeCurrent(window, nullptr);
+
+    glm::mat4 cameraRotation(1);
+    float cameraDist = 2.f;
+    bool mousePressed = false;
+    // taken when the event is read, the time it spent in the OS queue is not accounted for
+    Uint64 lastInputTimestamp = 0;
+    glm::vec3 cubeRot = {0,0,0};
+    const glm::vec3 rotSpeed = {0.5f, 0.3f, 0};
+
+    // the first packets must be ready before the render thread starts reading them
+    auto publishCamera = [&] {
+        CameraLatch& latch = cameraLatches.writeSlot();
+        latch.rotation = cameraRotation;
+        latch.distance = cameraDist;
+        latch.inputTimestamp = lastInputTimestamp;
+        cameraLatches.publish();
+    };
+    auto publishFrame = [&] {
+        FramePacket& packet = framePackets.writeSlot();
+        packet.modelMtx = glm::yawPitchRoll(cubeRot.x, cubeRot.y, cubeRot.z);
+        SDL_GetWindowSize(window, &packet.windowW, &packet.windowH);
+        framePackets.publish();
+    };
+    publishCamera();
+    publishFrame();
+    std::thread renderThread(renderThreadFn);
+
+    int prevTicks = SDL_GetTicks();
+    while(gameLoopRunning)
+    {
+        const int newTicks = SDL_GetTicks();
+        const int deltaTicks = newTicks - prevTicks;
+        const float dt = 0.001f * deltaTicks;
+        prevTicks = newTicks;
+        static SDL_Event event;
+        while(SDL_PollEvent(&event))
+        {
+            switch(event.type)
+            {
+            case SDL_QUIT:
+                gameLoopRunning = false;
+                break;
+            case SDL_MOUSEBUTTONDOWN:
+                mousePressed = true;
+                break;
+            case SDL_MOUSEBUTTONUP:
+                mousePressed = false;
+                break;
+            case SDL_MOUSEMOTION:
+                if(mousePressed) {
+                    int w, h;
+                    SDL_GetWindowSize(window, &w, &h);
+                    cameraRotation = glm::eulerAngleXY(3.14f * event.motion.yrel / h, 3.14f * event.motion.xrel / w) * cameraRotation;
+                    lastInputTimestamp = SDL_GetPerformanceCounter();
+                }
+                break;
+            case SDL_MOUSEWHEEL:
+                cameraDist -= 0.1f*event.wheel.y;
+                cameraDist = tl::max(0.1f, cameraDist);
+                lastInputTimestamp = SDL_GetPerformanceCounter();
+                break;
+            case SDL_KEYDOWN:
+                if(event.key.keysym.sym >= SDLK_1 && event.key.keysym.sym <= SDLK_3) {
+                    framesInFlight = 1 + event.key.keysym.sym - SDLK_1;
+                    printf("frames in flight: %d\n", framesInFlight.load());
+                }
+                break;
+            }
+        }
+        publishCamera();
+
+        cubeRot += rotSpeed * dt;
+        publishFrame();
+
+        // the render thread paces itself with vsync, here we only need to sample the input often enough
+        SDL_Delay(1);
+    }
+
+    renderThread.join();
+    SDL_GL_DeleteContext(glContext);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+}
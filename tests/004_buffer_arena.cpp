@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <vector>
+#include <SDL.h>
+#include <glad/glad.h>
+#include <tgl/context.hpp>
+#include <tgl/render_target.hpp>
+#include <glm/vec3.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "buffer_arena.hpp"
+#include "vertex_layout.hpp"
+
+// A long strip of cubes, each one with its own mesh, streamed into a BufferArena as the camera scrolls over it
+// The budget only fits a part of the strip, so the cubes that went out of view get evicted
+// The arena stats are printed once per second
+
+static SDL_Window* window = nullptr;
+static SDL_GLContext glContext;
+static bool gameLoopRunning = true;
+
+static const char vertShaderSrc[] = R"GLSL(
+#version 330
+
+out vec3 color;
+
+uniform mat4 u_viewProj;
+
+void main()
+{
+    color = a_color;
+    gl_Position = u_viewProj * vec4(a_pos, 1.0);
+}
+)GLSL";
+
+static const char fragShaderSrc[] = R"GLSL(
+#version 330
+
+layout(location = 0) out vec4 o_color;
+
+in vec3 color;
+
+void main()
+{
+    o_color = vec4(color, 1.0);
+}
+)GLSL";
+
+struct Vert
+{
+    glm::vec3 pos;
+    glm::vec3 color;
+};
+TW_VERTEX_LAYOUT(Vert,
+    TW_VERTEX_ATTRIB(Vert, pos, "a_pos"),
+    TW_VERTEX_ATTRIB(Vert, color, "a_color")
+)
+
+constexpr int numCubeVerts = 8;
+constexpr int numCubeInds = 36;
+static const u16 cubeIndices[numCubeInds] = {
+    0, 1, 3,  0, 3, 2, // -X
+    4, 6, 7,  4, 7, 5, // +X
+    0, 4, 5,  0, 5, 1, // -Y
+    2, 3, 7,  2, 7, 6, // +Y
+    0, 2, 6,  0, 6, 4, // -Z
+    1, 5, 7,  1, 7, 3, // +Z
+};
+constexpr u32 cubeVertsBytes = numCubeVerts * sizeof(Vert);
+constexpr u32 cubeMeshBytes = cubeVertsBytes + sizeof(cubeIndices);
+
+constexpr int STRIP_COLUMNS = 256;
+constexpr int STRIP_ROWS = 12;
+constexpr int VISIBLE_COLUMNS = 20;
+constexpr u32 SLAB_SIZE = 16 * 1024;
+constexpr u64 BUDGET = 6 * SLAB_SIZE;
+constexpr u32 DEFRAG_BYTES_PER_FRAME = 4 * 1024;
+
+constexpr int INIT_WINDOW_WIDTH = 800;
+constexpr int INIT_WINDOW_HEIGHT = 600;
+
+// the geometry is generated again every time a cube is streamed in, as if it was read from disk
+static void generateCube(int column, int row, Vert (&verts)[numCubeVerts])
+{
+    const u32 hash = (u32)(column * 73856093) ^ (u32)(row * 19349663);
+    const glm::vec3 color = {(hash & 0xFF) / 255.f, ((hash >> 8) & 0xFF) / 255.f, ((hash >> 16) & 0xFF) / 255.f};
+    const glm::vec3 center = {(float)column, (float)row, 0};
+    const float halfSize = 0.2f + 0.2f * ((hash >> 24) & 0xFF) / 255.f;
+    for(int i = 0; i < numCubeVerts; i++) {
+        const glm::vec3 corner = {(i & 4) ? +1.f : -1.f, (i & 2) ? +1.f : -1.f, (i & 1) ? +1.f : -1.f};
+        verts[i].pos = center + halfSize * corner;
+        verts[i].color = color * (0.6f + 0.05f * i);
+    }
+}
+
+void launch_test_4()
+{
+    if(SDL_Init(SDL_INIT_EVERYTHING) != 0) {
+        fprintf(stderr, "Error: %s\n", SDL_GetError());
+        return;
+    }
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+
+    window = SDL_CreateWindow("title",
+        SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+        INIT_WINDOW_WIDTH, INIT_WINDOW_HEIGHT,
+        SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE
+    );
+    glContext = SDL_GL_CreateContext(window);
+    SDL_GL_MakeCurrent(window, glContext);
+    SDL_GL_SetSwapInterval(1); // Enable vsync
+
+    if(gladLoadGL() == 0) {
+        fprintf(stderr, "Failed to initialize OpenGL loader!\n");
+    }
+    tgl::enableDepthTest(true);
+    tgl::viewport(INIT_WINDOW_WIDTH, INIT_WINDOW_HEIGHT);
+    tgl::scissor(INIT_WINDOW_WIDTH, INIT_WINDOW_HEIGHT);
+
+    // the granularity is the vertex size so every allocation can be addressed with a base vertex
+    auto arena = tw::BufferArena::create(SLAB_SIZE, BUDGET, sizeof(Vert));
+    static u32 cubeHandles[STRIP_COLUMNS][STRIP_ROWS];
+    for(auto& column : cubeHandles)
+        for(u32& handle : column)
+            handle = tw::BufferArena::INVALID;
+    // one VAO per slab: the offset of each mesh goes in the draw call, so defragmenting doesn't invalidate the VAOs
+    std::vector<GLuint> slabVaos;
+
+    // the vertex inputs get declared from the layout of Vert
+    const GLuint shader = tw::createShaderProgram<Vert>(vertShaderSrc, fragShaderSrc);
+    if(shader == 0)
+        gameLoopRunning = false;
+    const GLint viewProjLoc = shader ? glGetUniformLocation(shader, "u_viewProj") : -1;
+
+    int prevTicks = SDL_GetTicks();
+    int lastReportTicks = prevTicks;
+    float cameraX = 0;
+    while(gameLoopRunning)
+    {
+        const int newTicks = SDL_GetTicks();
+        const int deltaTicks = newTicks - prevTicks;
+        const float dt = 0.001f * deltaTicks;
+        prevTicks = newTicks;
+        static SDL_Event event;
+        while(SDL_PollEvent(&event))
+        {
+            switch(event.type)
+            {
+            case SDL_QUIT:
+                gameLoopRunning = false;
+                break;
+            case SDL_WINDOWEVENT:
+                if(event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+                {
+                    const i32 w = event.window.data1;
+                    const i32 h = event.window.data2;
+                    tgl::viewport(0, 0, w, h);
+                    tgl::scissor(0, 0, w, h);
+                }
+                break;
+            }
+        }
+
+        cameraX += 8.f * dt;
+        if(cameraX > STRIP_COLUMNS - VISIBLE_COLUMNS)
+            cameraX = 0;
+
+        glUseProgram(shader);
+        tgl::clear({0, 0.1f, 0.1f, 0.f});
+        int windowW, windowH;
+        SDL_GetWindowSize(window, &windowW, &windowH);
+        const auto projMtx = glm::perspective(glm::radians(60.f), (float)windowW / windowH, 0.1f, 100.f);
+        const glm::vec3 eye = {cameraX + 0.5f * VISIBLE_COLUMNS, 0.5f * STRIP_ROWS, 16.f};
+        const auto viewMtx = glm::lookAt(eye, eye - glm::vec3(0, 0, 1), {0, 1, 0});
+        const auto viewProjMtx = projMtx * viewMtx;
+        glUniformMatrix4fv(viewProjLoc, 1, GL_FALSE, &viewProjMtx[0][0]);
+
+        const int firstColumn = (int)cameraX;
+        for(int column = firstColumn; column < firstColumn + VISIBLE_COLUMNS; column++)
+        for(int row = 0; row < STRIP_ROWS; row++)
+        {
+            u32& handle = cubeHandles[column][row];
+            if(handle == tw::BufferArena::INVALID || !arena.isResident(handle)) {
+                if(handle != tw::BufferArena::INVALID)
+                    arena.dealloc(handle);
+                handle = arena.alloc(cubeMeshBytes, true);
+                if(handle == tw::BufferArena::INVALID)
+                    continue;
+                Vert verts[numCubeVerts];
+                generateCube(column, row, verts);
+                arena.upload(handle, verts, cubeVertsBytes);
+                arena.upload(handle, cubeIndices, sizeof(cubeIndices), cubeVertsBytes);
+            }
+            arena.touch(handle);
+
+            const u32 slab = arena.slab(handle);
+            while(slabVaos.size() <= slab) {
+                GLuint vao;
+                glGenVertexArrays(1, &vao);
+                glBindVertexArray(vao);
+                glBindBuffer(GL_ARRAY_BUFFER, arena.slabBuffer((u32)slabVaos.size()));
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena.slabBuffer((u32)slabVaos.size()));
+                tw::linkVertexLayout<Vert>();
+                slabVaos.push_back(vao);
+            }
+            const u32 offset = arena.offset(handle);
+            glBindVertexArray(slabVaos[slab]);
+            glDrawElementsBaseVertex(GL_TRIANGLES, numCubeInds, GL_UNSIGNED_SHORT,
+                (void*)(size_t)(offset + cubeVertsBytes), offset / sizeof(Vert));
+        }
+        glBindVertexArray(0);
+
+        arena.defragment(DEFRAG_BYTES_PER_FRAME);
+
+        if(newTicks - lastReportTicks >= 1000) {
+            lastReportTicks = newTicks;
+            const auto stats = arena.stats();
+            printf("slabs: %u KB, live: %u KB, fragmentation: %.2f, evictions: %u, moves: %u (%u KB)\n",
+                (u32)(stats.slabBytes / 1024), (u32)(stats.liveBytes / 1024), stats.fragmentation,
+                stats.evictions, stats.moves, (u32)(stats.movedBytes / 1024));
+        }
+
+        SDL_GL_SwapWindow(window);
+    }
+
+    glDeleteProgram(shader);
+    glDeleteVertexArrays((GLsizei)slabVaos.size(), slabVaos.data());
+    arena.free();
+    SDL_GL_DeleteContext(glContext);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+}
@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "range_allocator.hpp"
+
+// Checks of the RangeAllocator logic. It doesn't need a window or a GL context
+
+static int numChecks = 0;
+static int numFailedChecks = 0;
+
+#define CHECK(COND) \
+    do { \
+        numChecks++; \
+        if(!(COND)) { \
+            numFailedChecks++; \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #COND); \
+        } \
+    } while(0)
+
+using tw::RangeAllocator;
+constexpr u32 INVALID = RangeAllocator::INVALID;
+
+static void checkInvariants(const RangeAllocator& a)
+{
+    CHECK(a.usedBytes() + a.freeBytes() == a.capacity());
+    CHECK(a.largestFreeRange() <= a.freeBytes());
+    CHECK(a.fragmentation() >= 0 && a.fragmentation() <= 1);
+    if(a.freeBytes() && a.largestFreeRange() == a.freeBytes())
+        CHECK(a.fragmentation() == 0);
+}
+
+static void testFullCapacity()
+{
+    {
+        RangeAllocator a(16368, 24);
+        const u32 h = a.alloc(16368);
+        CHECK(h != INVALID);
+        CHECK(a.freeBytes() == 0);
+        CHECK(a.alloc(1) == INVALID);
+        if(h != INVALID) {
+            a.free(h);
+            CHECK(a.freeBytes() == 16368);
+        }
+    }
+    {
+        RangeAllocator a(1 << 20, 16);
+        CHECK(a.alloc(1 << 20) != INVALID);
+    }
+    {
+        RangeAllocator a(1 << 20, 16);
+        CHECK(a.alloc(1024000) != INVALID);
+        CHECK(a.alloc((1 << 20) - 1024000) != INVALID);
+        CHECK(a.freeBytes() == 0);
+    }
+    {
+        RangeAllocator a(4096, 16);
+        CHECK(a.alloc(4097) == INVALID);
+        CHECK(a.alloc(0xFFFFFFFF) == INVALID);
+        CHECK(a.alloc(0xFFFFFFFF - 8) == INVALID);
+        CHECK(a.freeBytes() == 4096);
+    }
+}
+
+static void testExactFit()
+{
+    // the free block left in the middle has exactly the size of the request, which the good fit round up skips
+    RangeAllocator a(32 * 1024, 16);
+    const u32 h0 = a.alloc(1000 * 16);
+    const u32 h1 = a.alloc(70 * 16);
+    const u32 h2 = a.alloc(a.freeBytes());
+    CHECK(h0 != INVALID && h1 != INVALID && h2 != INVALID);
+    if(h1 == INVALID || h2 == INVALID)
+        return;
+    a.free(h1);
+    const u32 h3 = a.alloc(70 * 16);
+    CHECK(h3 != INVALID);
+    if(h3 != INVALID)
+        CHECK(a.offset(h3) == 1000 * 16);
+    checkInvariants(a);
+}
+
+static void testCoalescing()
+{
+    RangeAllocator a(1024, 16);
+    u32 h[4];
+    for(u32& handle : h) {
+        handle = a.alloc(256);
+        CHECK(handle != INVALID);
+    }
+    CHECK(a.freeBytes() == 0);
+
+    a.free(h[1]);
+    a.free(h[3]);
+    CHECK(a.freeBytes() == 512);
+    CHECK(a.largestFreeRange() == 256);
+    CHECK(a.fragmentation() == 0.5f);
+    CHECK(a.alloc(512) == INVALID);
+
+    // freeing the block in between merges the three ranges
+    a.free(h[2]);
+    CHECK(a.largestFreeRange() == 768);
+    CHECK(a.fragmentation() == 0);
+    const u32 big = a.alloc(768);
+    CHECK(big != INVALID);
+    if(big != INVALID)
+        CHECK(a.offset(big) == 256);
+    checkInvariants(a);
+}
+
+static void testDefragment()
+{
+    // simulated buffer contents, to check that applying the moves in order keeps the data of every allocation
+    RangeAllocator a(1024, 16);
+    std::vector<unsigned char> mem(1024);
+    u32 h[8];
+    for(int i = 0; i < 8; i++) {
+        h[i] = a.alloc(i == 2 ? 64 : 128 + 16 * (i % 2));
+        CHECK(h[i] != INVALID);
+        memset(&mem[a.offset(h[i])], i + 1, a.size(h[i]));
+    }
+    a.free(h[0]);
+    a.free(h[2]);
+    a.free(h[5]);
+    CHECK(a.fragmentation() > 0);
+
+    // the limit is in bytes, but at least one move happens
+    std::vector<RangeAllocator::Move> moves;
+    const u32 firstMovedBytes = a.defragment(1, moves);
+    CHECK(moves.size() == 1);
+    CHECK(firstMovedBytes == moves[0].size);
+    CHECK(moves[0].handle == h[1]);
+    CHECK(moves[0].dstOffset == 0);
+    // h[1] is bigger than the hole before it, so source and destination overlap
+    CHECK(moves[0].dstOffset + moves[0].size > moves[0].srcOffset);
+
+    // appended after the first move, so the whole list gets applied in order
+    const u32 movedBytes = a.defragment(~0u, moves);
+    CHECK(movedBytes > 0);
+    for(const RangeAllocator::Move& move : moves)
+        memmove(&mem[move.dstOffset], &mem[move.srcOffset], move.size);
+    CHECK(a.fragmentation() == 0);
+    CHECK(a.largestFreeRange() == a.freeBytes());
+    CHECK(a.freeBytes() == a.capacity() - a.usedBytes());
+
+    u32 expectedOffset = 0;
+    const int live[] = {1, 3, 4, 6, 7};
+    for(int i : live) {
+        CHECK(a.offset(h[i]) == expectedOffset);
+        for(u32 b = 0; b < a.size(h[i]); b++)
+            CHECK(mem[a.offset(h[i]) + b] == i + 1);
+        expectedOffset += a.size(h[i]);
+    }
+
+    // nothing left to move
+    moves.clear();
+    CHECK(a.defragment(~0u, moves) == 0);
+    CHECK(moves.empty());
+}
+
+static void testDefragmentLimit()
+{
+    // the limit can't be exceeded once the first range has been moved, even if the next range is big
+    RangeAllocator a(32 * 1024, 16);
+    const u32 h0 = a.alloc(1024);
+    const u32 h1 = a.alloc(4000);
+    const u32 h2 = a.alloc(16000);
+    const u32 h3 = a.alloc(1024);
+    CHECK(h0 != INVALID && h1 != INVALID && h2 != INVALID && h3 != INVALID);
+    a.free(h0);
+
+    std::vector<RangeAllocator::Move> moves;
+    const u32 movedBytes = a.defragment(4096, moves);
+    CHECK(movedBytes <= 4096);
+    CHECK(moves.size() == 1);
+    CHECK(moves[0].handle == h1);
+
+    // a limit smaller than the first range still moves that range
+    moves.clear();
+    CHECK(a.defragment(16, moves) == a.size(h2));
+    CHECK(moves.size() == 1);
+
+    moves.clear();
+    CHECK(a.defragment(~0u, moves) == a.size(h3));
+    CHECK(a.fragmentation() == 0);
+    checkInvariants(a);
+}
+
+static void testRandomOperations()
+{
+    RangeAllocator a(64 * 1024, 16);
+    std::vector<u32> live;
+    std::vector<RangeAllocator::Move> moves;
+    srand(1234);
+    for(int i = 0; i < 20000; i++)
+    {
+        const int op = rand() % 10;
+        if(op < 5) {
+            const u32 size = 1 + rand() % 3000;
+            const u32 h = a.alloc(size);
+            if(h == INVALID)
+                CHECK(a.largestFreeRange() < (size + 15) / 16 * 16);
+            else {
+                CHECK(a.size(h) >= size);
+                live.push_back(h);
+            }
+        }
+        else if(op < 9 && live.size()) {
+            const u32 ind = rand() % live.size();
+            a.free(live[ind]);
+            live[ind] = live.back();
+            live.pop_back();
+        }
+        else {
+            moves.clear();
+            const u32 maxBytes = rand() % 4096;
+            const u32 movedBytes = a.defragment(maxBytes, moves);
+            CHECK(moves.size() <= 1 || movedBytes <= maxBytes);
+        }
+        checkInvariants(a);
+    }
+
+    u32 usedBytes = 0;
+    for(u32 h : live)
+        usedBytes += a.size(h);
+    CHECK(usedBytes == a.usedBytes());
+    for(u32 h : live)
+        a.free(h);
+    CHECK(a.freeBytes() == a.capacity());
+    CHECK(a.largestFreeRange() == a.capacity());
+}
+
+void launch_test_5()
+{
+    testFullCapacity();
+    testExactFit();
+    testCoalescing();
+    testDefragment();
+    testDefragmentLimit();
+    testRandomOperations();
+    printf("range_allocator: %d of %d checks passed\n", numChecks - numFailedChecks, numChecks);
+}
@@ -0,0 +1,238 @@
+#include "buffer_arena.hpp"
+#include <stdio.h>
+#include <assert.h>
+
+namespace tw
+{
+
+BufferArena BufferArena::create(u32 slabSize, u64 budget, u32 granularity)
+{
+    BufferArena arena;
+    arena._slabSize = slabSize - slabSize % granularity;
+    arena._granularity = granularity;
+    arena._budget = budget;
+    return arena;
+}
+
+void BufferArena::free()
+{
+    for(Slab& slab : _slabs)
+        glDeleteBuffers(1, &slab.buffer);
+    if(_scratchBuffer)
+        glDeleteBuffers(1, &_scratchBuffer);
+    *this = BufferArena();
+}
+
+u32 BufferArena::alloc(u32 size, bool evictable)
+{
+    const u64 roundedSize = ((u64)size + _granularity - 1) / _granularity * _granularity;
+    if(roundedSize > _slabSize) {
+        fprintf(stderr, "BufferArena: allocation of %u bytes is bigger than the slab size (%u)\n", size, _slabSize);
+        return INVALID;
+    }
+
+    u32 handle = INVALID;
+    for(u32 slab = 0; slab < _slabs.size() && handle == INVALID; slab++)
+        handle = allocInSlab(slab, size);
+
+    if(handle == INVALID && (u64)(_slabs.size() + 1) * _slabSize <= _budget) {
+        Slab slab;
+        glGenBuffers(1, &slab.buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, slab.buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, _slabSize, nullptr, GL_STATIC_DRAW);
+        slab.ranges = RangeAllocator(_slabSize, _granularity);
+        slab.evictableBytes = 0;
+        _slabs.push_back(slab);
+        handle = allocInSlab((u32)_slabs.size() - 1, size);
+    }
+
+    // over budget: make room by evicting the least recently used allocations
+    // only from slabs where that could be enough, so an impossible allocation doesn't empty the arena
+    while(handle == INVALID) {
+        const u32 victim = findVictim((u32)roundedSize);
+        if(victim == INVALID)
+            break;
+        const u32 slab = _allocations[victim].slab;
+        evict(victim);
+        handle = allocInSlab(slab, size);
+    }
+
+    if(handle != INVALID) {
+        Allocation& allocation = _allocations[handle];
+        allocation.evictable = evictable;
+        if(evictable) {
+            _slabs[allocation.slab].evictableBytes += _slabs[allocation.slab].ranges.size(allocation.range);
+            lruPushBack(handle);
+        }
+    }
+    return handle;
+}
+
+void BufferArena::dealloc(u32 handle)
+{
+    Allocation& allocation = _allocations[handle];
+    if(allocation.range != INVALID) {
+        Slab& slab = _slabs[allocation.slab];
+        if(allocation.evictable) {
+            slab.evictableBytes -= slab.ranges.size(allocation.range);
+            lruRemove(handle);
+        }
+        slab.ranges.free(allocation.range);
+        allocation.range = INVALID;
+    }
+    _unusedHandles.push_back(handle);
+}
+
+void BufferArena::upload(u32 handle, const void* data, u32 size, u32 offset)
+{
+    const Allocation& allocation = _allocations[handle];
+    assert(allocation.range != INVALID && offset + size <= allocation.size);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _slabs[allocation.slab].buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, this->offset(handle) + offset, size, data);
+}
+
+void BufferArena::touch(u32 handle)
+{
+    const Allocation& allocation = _allocations[handle];
+    if(allocation.evictable && allocation.range != INVALID && _lruLast != handle) {
+        lruRemove(handle);
+        lruPushBack(handle);
+    }
+}
+
+u32 BufferArena::offset(u32 handle)const
+{
+    const Allocation& allocation = _allocations[handle];
+    assert(allocation.range != INVALID); // evicted, check isResident()
+    return _slabs[allocation.slab].ranges.offset(allocation.range);
+}
+
+void BufferArena::defragment(u32 maxBytes)
+{
+    u32 movedBytes = 0;
+    for(u32 slabInd = 0; slabInd < _slabs.size() && movedBytes < maxBytes; slabInd++)
+    {
+        Slab& slab = _slabs[slabInd];
+        if(slab.ranges.fragmentation() == 0)
+            continue;
+        _moves.clear();
+        movedBytes += slab.ranges.defragment(maxBytes - movedBytes, _moves);
+
+        glBindBuffer(GL_COPY_READ_BUFFER, slab.buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, slab.buffer);
+        for(const RangeAllocator::Move& move : _moves)
+        {
+            if(move.dstOffset + move.size <= move.srcOffset) {
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, move.srcOffset, move.dstOffset, move.size);
+            }
+            else {
+                // overlapping copies within the same buffer are not allowed, go through the scratch buffer
+                if(_scratchSize < move.size) {
+                    if(_scratchBuffer == 0)
+                        glGenBuffers(1, &_scratchBuffer);
+                    _scratchSize = move.size;
+                    glBindBuffer(GL_COPY_WRITE_BUFFER, _scratchBuffer);
+                    glBufferData(GL_COPY_WRITE_BUFFER, _scratchSize, nullptr, GL_DYNAMIC_COPY);
+                }
+                glBindBuffer(GL_COPY_WRITE_BUFFER, _scratchBuffer);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, move.srcOffset, 0, move.size);
+                glBindBuffer(GL_COPY_READ_BUFFER, _scratchBuffer);
+                glBindBuffer(GL_COPY_WRITE_BUFFER, slab.buffer);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, move.dstOffset, move.size);
+                glBindBuffer(GL_COPY_READ_BUFFER, slab.buffer);
+            }
+            _movedBytes += move.size;
+        }
+        _numMoves += (u32)_moves.size();
+    }
+}
+
+BufferArena::Stats BufferArena::stats()const
+{
+    Stats stats = {};
+    // fragmentation of each slab weighted by its free bytes: the free bytes that are not in the largest range of their slab
+    u64 scatteredBytes = 0;
+    for(const Slab& slab : _slabs) {
+        stats.slabBytes += slab.ranges.capacity();
+        stats.liveBytes += slab.ranges.usedBytes();
+        stats.freeBytes += slab.ranges.freeBytes();
+        scatteredBytes += slab.ranges.freeBytes() - slab.ranges.largestFreeRange();
+    }
+    stats.fragmentation = stats.freeBytes ? (float)scatteredBytes / stats.freeBytes : 0.f;
+    stats.evictions = _evictions;
+    stats.moves = _numMoves;
+    stats.movedBytes = _movedBytes;
+    return stats;
+}
+
+u32 BufferArena::allocInSlab(u32 slab, u32 size)
+{
+    const u32 range = _slabs[slab].ranges.alloc(size);
+    if(range == RangeAllocator::INVALID)
+        return INVALID;
+    u32 handle;
+    if(_unusedHandles.size()) {
+        handle = _unusedHandles.back();
+        _unusedHandles.pop_back();
+    }
+    else {
+        handle = (u32)_allocations.size();
+        _allocations.emplace_back();
+    }
+    Allocation& allocation = _allocations[handle];
+    allocation.slab = slab;
+    allocation.range = range;
+    allocation.size = size;
+    allocation.lruPrev = allocation.lruNext = INVALID;
+    allocation.evictable = false;
+    return handle;
+}
+
+u32 BufferArena::findVictim(u32 size)const
+{
+    for(u32 handle = _lruFirst; handle != INVALID; handle = _allocations[handle].lruNext) {
+        const Slab& slab = _slabs[_allocations[handle].slab];
+        if((u64)slab.ranges.freeBytes() + slab.evictableBytes >= size)
+            return handle;
+    }
+    return INVALID;
+}
+
+void BufferArena::evict(u32 handle)
+{
+    Allocation& allocation = _allocations[handle];
+    Slab& slab = _slabs[allocation.slab];
+    slab.evictableBytes -= slab.ranges.size(allocation.range);
+    lruRemove(handle);
+    slab.ranges.free(allocation.range);
+    allocation.range = INVALID;
+    _evictions++;
+}
+
+void BufferArena::lruRemove(u32 handle)
+{
+    Allocation& allocation = _allocations[handle];
+    if(allocation.lruPrev != INVALID)
+        _allocations[allocation.lruPrev].lruNext = allocation.lruNext;
+    else
+        _lruFirst = allocation.lruNext;
+    if(allocation.lruNext != INVALID)
+        _allocations[allocation.lruNext].lruPrev = allocation.lruPrev;
+    else
+        _lruLast = allocation.lruPrev;
+    allocation.lruPrev = allocation.lruNext = INVALID;
+}
+
+void BufferArena::lruPushBack(u32 handle)
+{
+    Allocation& allocation = _allocations[handle];
+    allocation.lruPrev = _lruLast;
+    allocation.lruNext = INVALID;
+    if(_lruLast != INVALID)
+        _allocations[_lruLast].lruNext = handle;
+    else
+        _lruFirst = handle;
+    _lruLast = handle;
+}
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <glad/glad.h>
+#include <tl/int_types.hpp>
+#include "range_allocator.hpp"
+
+namespace tw
+{
+
+// Suballocates ranges of a few big GL buffers (slabs) instead of creating one buffer per mesh
+// The total size of the slabs is kept under a budget: when it's reached, the least recently used evictable
+// allocations are released. The owner of an evicted allocation must check isResident() and stream it again
+// Offsets can change when defragmenting, so don't bake them into VAOs: query offset() when drawing
+class BufferArena
+{
+public:
+    static constexpr u32 INVALID = u32(-1);
+
+    struct Stats {
+        u64 slabBytes;
+        u64 liveBytes;
+        u64 freeBytes;
+        float fragmentation; // 0 when every slab has its free space in one piece
+        u32 evictions;
+        u32 moves;
+        u64 movedBytes;
+    };
+
+    static BufferArena create(u32 slabSize, u64 budget, u32 granularity = 16);
+    void free();
+
+    // returns INVALID when the budget is full and there is nothing left to evict
+    u32 alloc(u32 size, bool evictable = false);
+    // handles must be deallocated even if they were evicted
+    void dealloc(u32 handle);
+    void upload(u32 handle, const void* data, u32 size, u32 offset = 0);
+    // marks the allocation as the most recently used one
+    void touch(u32 handle);
+
+    bool isResident(u32 handle)const { return _allocations[handle].range != INVALID; }
+    u32 slab(u32 handle)const { return _allocations[handle].slab; }
+    u32 offset(u32 handle)const;
+    u32 numSlabs()const { return (u32)_slabs.size(); }
+    GLuint slabBuffer(u32 slab)const { return _slabs[slab].buffer; }
+
+    // moves at most maxBytes with buffer copies in the GPU. Call it once per frame with a small amount
+    void defragment(u32 maxBytes);
+
+    Stats stats()const;
+
+private:
+    struct Slab {
+        GLuint buffer;
+        RangeAllocator ranges;
+        u32 evictableBytes;
+    };
+    struct Allocation {
+        u32 slab;
+        u32 range;
+        u32 size;
+        u32 lruPrev, lruNext;
+        bool evictable;
+    };
+
+    u32 allocInSlab(u32 slab, u32 size);
+    // the least recently used allocation whose eviction could help fitting size bytes, or INVALID
+    u32 findVictim(u32 size)const;
+    void evict(u32 handle);
+    void lruRemove(u32 handle);
+    void lruPushBack(u32 handle);
+
+    std::vector<Slab> _slabs;
+    std::vector<Allocation> _allocations;
+    std::vector<u32> _unusedHandles;
+    std::vector<RangeAllocator::Move> _moves;
+    u32 _lruFirst = INVALID, _lruLast = INVALID;
+    u32 _slabSize = 0;
+    u32 _granularity = 16;
+    u64 _budget = 0;
+    GLuint _scratchBuffer = 0;
+    u32 _scratchSize = 0;
+    u32 _evictions = 0;
+    u32 _numMoves = 0;
+    u64 _movedBytes = 0;
+};
+
+}
@@ -0,0 +1,89 @@
+#include "frame_pipeline.hpp"
+#include <stdio.h>
+
+namespace tw
+{
+
+float secondsSince(Uint64 timestamp)
+{
+    const Uint64 now = SDL_GetPerformanceCounter();
+    return (float)(now - timestamp) / SDL_GetPerformanceFrequency();
+}
+
+// -- FrameFences --
+
+Uint64 FrameFences::waitForSlot(int framesInFlight)
+{
+    if(framesInFlight < 1)
+        framesInFlight = 1;
+    else if(framesInFlight > MAX_FRAMES_IN_FLIGHT)
+        framesInFlight = MAX_FRAMES_IN_FLIGHT;
+    if(framesInFlight != _framesInFlight) {
+        // the ring size changes: drain everything and start over
+        waitAll();
+        _framesInFlight = framesInFlight;
+        _next = 0;
+        return 0;
+    }
+
+    GLsync& fence = _fences[_next];
+    if(fence == nullptr)
+        return 0;
+    glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    glDeleteSync(fence);
+    fence = nullptr;
+    return _timestamps[_next];
+}
+
+void FrameFences::insert(Uint64 inputTimestamp)
+{
+    _fences[_next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _timestamps[_next] = inputTimestamp;
+    _next = (_next + 1) % _framesInFlight;
+}
+
+void FrameFences::waitAll()
+{
+    for(int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        if(_fences[i]) {
+            glClientWaitSync(_fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(_fences[i]);
+            _fences[i] = nullptr;
+        }
+    }
+}
+
+// -- LatencyStats --
+
+LatencyStats::LatencyStats(const char* name, float reportPeriod)
+    : _name(name)
+    , _reportPeriod(reportPeriod)
+{
+    reset();
+}
+
+void LatencyStats::addSample(float seconds)
+{
+    if(seconds < _min)
+        _min = seconds;
+    if(seconds > _max)
+        _max = seconds;
+    _sum += seconds;
+    _count++;
+    if(secondsSince(_periodStart) >= _reportPeriod) {
+        printf("%s latency (ms): min %.2f, avg %.2f, max %.2f (%d samples)\n",
+            _name, 1000.f * _min, 1000.f * _sum / _count, 1000.f * _max, _count);
+        reset();
+    }
+}
+
+void LatencyStats::reset()
+{
+    _periodStart = SDL_GetPerformanceCounter();
+    _min = 1e9f;
+    _max = 0;
+    _sum = 0;
+    _count = 0;
+}
+
+}
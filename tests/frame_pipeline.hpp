@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <SDL.h>
+#include <glad/glad.h>
+#include <tl/int_types.hpp>
+
+namespace tw
+{
+
+// Lock-free single-producer/single-consumer triple buffer
+// The producer always has a slot to write to and the consumer always gets the most recent published slot
+// Neither side ever waits for the other
+template <typename T>
+class TripleBuffer
+{
+public:
+    // producer side
+    T& writeSlot() { return _slots[_writeInd]; }
+    void publish();
+
+    // consumer side. Returns true if a new slot was published since the last fetch
+    bool fetch();
+    const T& readSlot()const { return _slots[_readInd]; }
+
+private:
+    static constexpr u8 DIRTY_BIT = 1 << 2;
+    static constexpr u8 INDEX_MASK = DIRTY_BIT - 1;
+
+    T _slots[3] = {};
+    std::atomic<u8> _shared = {1};
+    u8 _writeInd = 0;
+    u8 _readInd = 2;
+};
+
+// Keeps at most N frames queued in the GPU (1 to 3) by waiting on a fence inserted after each swap
+// Fewer frames in flight means less input latency at the cost of less CPU/GPU overlap
+class FrameFences
+{
+public:
+    static constexpr int MAX_FRAMES_IN_FLIGHT = 3;
+
+    // waits until there is room for one more frame
+    // Returns the input timestamp the retired frame was inserted with, or 0 if there was none
+    Uint64 waitForSlot(int framesInFlight);
+    void insert(Uint64 inputTimestamp);
+    void waitAll();
+
+private:
+    GLsync _fences[MAX_FRAMES_IN_FLIGHT] = {};
+    Uint64 _timestamps[MAX_FRAMES_IN_FLIGHT] = {};
+    int _framesInFlight = MAX_FRAMES_IN_FLIGHT;
+    int _next = 0;
+};
+
+// Accumulates latency samples (in seconds) and prints min/avg/max once per period
+class LatencyStats
+{
+public:
+    explicit LatencyStats(const char* name, float reportPeriod = 1.f);
+    void addSample(float seconds);
+    void reset();
+
+private:
+    const char* _name;
+    float _reportPeriod;
+    Uint64 _periodStart;
+    float _min, _max, _sum;
+    int _count;
+};
+
+// seconds elapsed since a SDL_GetPerformanceCounter() timestamp
+float secondsSince(Uint64 timestamp);
+
+// --- IMPL ---
+
+template <typename T>
+void TripleBuffer<T>::publish()
+{
+    const u8 prev = _shared.exchange(_writeInd | DIRTY_BIT, std::memory_order_acq_rel);
+    _writeInd = prev & INDEX_MASK;
+}
+
+template <typename T>
+bool TripleBuffer<T>::fetch()
+{
+    if((_shared.load(std::memory_order_relaxed) & DIRTY_BIT) == 0)
+        return false;
+    const u8 prev = _shared.exchange(_readInd, std::memory_order_acq_rel);
+    _readInd = prev & INDEX_MASK;
+    return true;
+}
+
+}
@@ -0,0 +1,285 @@
+#include "range_allocator.hpp"
+#include <assert.h>
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+namespace tw
+{
+
+static u32 mostSignificantBit(u32 x)
+{
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanReverse(&i, x);
+    return i;
+#else
+    return 31 - __builtin_clz(x);
+#endif
+}
+
+static u32 leastSignificantBit(u32 x)
+{
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward(&i, x);
+    return i;
+#else
+    return __builtin_ctz(x);
+#endif
+}
+
+// first and second level indices of the size class that contains "units"
+static void mapping(u32 units, u32 SL_BITS, u32& fl, u32& sl)
+{
+    const u32 SL_COUNT = 1 << SL_BITS;
+    if(units < SL_COUNT) {
+        fl = 0;
+        sl = units;
+    }
+    else {
+        const u32 msb = mostSignificantBit(units);
+        fl = msb - SL_BITS + 1;
+        sl = (units >> (msb - SL_BITS)) - SL_COUNT;
+    }
+}
+
+RangeAllocator::RangeAllocator(u32 capacity, u32 granularity)
+    : _capacity(capacity / granularity)
+    , _granularity(granularity)
+{
+    for(auto& heads : _freeHeads)
+        for(u32& head : heads)
+            head = INVALID;
+    if(_capacity == 0)
+        return;
+    _firstBlock = newBlock();
+    Block& block = _blocks[_firstBlock];
+    block.offset = 0;
+    block.size = _capacity;
+    block.prevPhys = block.nextPhys = INVALID;
+    insertFree(_firstBlock);
+}
+
+u32 RangeAllocator::alloc(u32 size)
+{
+    // in 64 bits, sizes close to the u32 limit would wrap around
+    u64 roundedUnits = ((u64)size + _granularity - 1) / _granularity;
+    if(roundedUnits == 0)
+        roundedUnits = 1;
+    if(roundedUnits > _capacity)
+        return INVALID;
+    const u32 units = (u32)roundedUnits;
+    const u32 b = findFree(units);
+    if(b == INVALID)
+        return INVALID;
+    removeFree(b);
+
+    const u32 remaining = _blocks[b].size - units;
+    if(remaining) {
+        const u32 rest = newBlock(); // can reallocate _blocks, don't hold references across this call
+        Block& block = _blocks[b];
+        Block& restBlock = _blocks[rest];
+        block.size = units;
+        restBlock.offset = block.offset + units;
+        restBlock.size = remaining;
+        restBlock.prevPhys = b;
+        restBlock.nextPhys = block.nextPhys;
+        if(block.nextPhys != INVALID)
+            _blocks[block.nextPhys].prevPhys = rest;
+        block.nextPhys = rest;
+        insertFree(rest);
+    }
+    return b;
+}
+
+void RangeAllocator::free(u32 handle)
+{
+    assert(handle < _blocks.size() && !_blocks[handle].isFree);
+    u32 b = handle;
+    const u32 next = _blocks[b].nextPhys;
+    if(next != INVALID && _blocks[next].isFree) {
+        removeFree(next);
+        absorbNext(b);
+    }
+    const u32 prev = _blocks[b].prevPhys;
+    if(prev != INVALID && _blocks[prev].isFree) {
+        removeFree(prev);
+        absorbNext(prev);
+        b = prev;
+    }
+    insertFree(b);
+}
+
+u32 RangeAllocator::defragment(u32 maxBytes, std::vector<Move>& moves)
+{
+    u32 movedBytes = 0;
+    u32 hole = _firstBlock;
+    while(hole != INVALID && !_blocks[hole].isFree)
+        hole = _blocks[hole].nextPhys;
+
+    // the hole bubbles up: each used block that follows it gets slid down to the hole's offset
+    while(hole != INVALID)
+    {
+        const u32 b = _blocks[hole].nextPhys;
+        if(b == INVALID)
+            break;
+        Block& holeBlock = _blocks[hole];
+        Block& block = _blocks[b];
+        assert(!block.isFree);
+
+        // the first move always happens so there is progress, the rest must fit in the limit
+        const u32 blockBytes = block.size * _granularity;
+        if(movedBytes > 0 && (u64)movedBytes + blockBytes > maxBytes)
+            break;
+        moves.push_back({b, block.offset * _granularity, holeBlock.offset * _granularity, blockBytes});
+        movedBytes += blockBytes;
+
+        removeFree(hole);
+        block.offset = holeBlock.offset;
+        holeBlock.offset = block.offset + block.size;
+        // swap physical order: prev <-> hole <-> b <-> next  ==>  prev <-> b <-> hole <-> next
+        const u32 prev = holeBlock.prevPhys;
+        const u32 next = block.nextPhys;
+        block.prevPhys = prev;
+        block.nextPhys = hole;
+        holeBlock.prevPhys = b;
+        holeBlock.nextPhys = next;
+        if(prev != INVALID)
+            _blocks[prev].nextPhys = b;
+        else
+            _firstBlock = b;
+        if(next != INVALID) {
+            _blocks[next].prevPhys = hole;
+            if(_blocks[next].isFree) {
+                removeFree(next);
+                absorbNext(hole);
+            }
+        }
+        insertFree(hole);
+    }
+    return movedBytes;
+}
+
+u32 RangeAllocator::largestFreeRange()const
+{
+    if(_flBitmap == 0)
+        return 0;
+    const u32 fl = mostSignificantBit(_flBitmap);
+    const u32 sl = mostSignificantBit(_slBitmaps[fl]);
+    u32 largest = 0;
+    for(u32 b = _freeHeads[fl][sl]; b != INVALID; b = _blocks[b].nextFree)
+        if(_blocks[b].size > largest)
+            largest = _blocks[b].size;
+    return largest * _granularity;
+}
+
+float RangeAllocator::fragmentation()const
+{
+    if(_freeUnits == 0)
+        return 0;
+    return 1.f - (float)largestFreeRange() / freeBytes();
+}
+
+u32 RangeAllocator::newBlock()
+{
+    u32 b = _unusedBlocks;
+    if(b != INVALID)
+        _unusedBlocks = _blocks[b].nextFree;
+    else {
+        b = (u32)_blocks.size();
+        _blocks.emplace_back();
+    }
+    _blocks[b].isFree = false;
+    return b;
+}
+
+void RangeAllocator::recycleBlock(u32 b)
+{
+    _blocks[b].nextFree = _unusedBlocks;
+    _unusedBlocks = b;
+}
+
+void RangeAllocator::insertFree(u32 b)
+{
+    Block& block = _blocks[b];
+    u32 fl, sl;
+    mapping(block.size, SL_BITS, fl, sl);
+    u32& head = _freeHeads[fl][sl];
+    block.isFree = true;
+    block.prevFree = INVALID;
+    block.nextFree = head;
+    if(head != INVALID)
+        _blocks[head].prevFree = b;
+    head = b;
+    _flBitmap |= 1u << fl;
+    _slBitmaps[fl] |= 1u << sl;
+    _freeUnits += block.size;
+}
+
+void RangeAllocator::removeFree(u32 b)
+{
+    Block& block = _blocks[b];
+    u32 fl, sl;
+    mapping(block.size, SL_BITS, fl, sl);
+    if(block.prevFree != INVALID)
+        _blocks[block.prevFree].nextFree = block.nextFree;
+    else
+        _freeHeads[fl][sl] = block.nextFree;
+    if(block.nextFree != INVALID)
+        _blocks[block.nextFree].prevFree = block.prevFree;
+    if(_freeHeads[fl][sl] == INVALID) {
+        _slBitmaps[fl] &= ~(1u << sl);
+        if(_slBitmaps[fl] == 0)
+            _flBitmap &= ~(1u << fl);
+    }
+    block.isFree = false;
+    _freeUnits -= block.size;
+}
+
+u32 RangeAllocator::findFree(u32 units)const
+{
+    if(units > _freeUnits)
+        return INVALID;
+
+    // good fit: round up to the next size class so any block found in it, or above, is big enough
+    u64 rounded = units;
+    if(units >= SL_COUNT)
+        rounded += (1u << (mostSignificantBit(units) - SL_BITS)) - 1;
+    if(rounded <= 0xFFFFFFFF) {
+        u32 fl, sl;
+        mapping((u32)rounded, SL_BITS, fl, sl);
+        u32 slBits = _slBitmaps[fl] & (~0u << sl);
+        if(slBits == 0) {
+            const u32 flBits = _flBitmap & (~0u << (fl + 1));
+            if(flBits) {
+                fl = leastSignificantBit(flBits);
+                slBits = _slBitmaps[fl];
+            }
+        }
+        if(slBits)
+            return _freeHeads[fl][leastSignificantBit(slBits)];
+    }
+
+    // exact fit: the round up skips the class of "units", which can still have big enough blocks
+    u32 fl, sl;
+    mapping(units, SL_BITS, fl, sl);
+    for(u32 b = _freeHeads[fl][sl]; b != INVALID; b = _blocks[b].nextFree)
+        if(_blocks[b].size >= units)
+            return b;
+    return INVALID;
+}
+
+void RangeAllocator::absorbNext(u32 b)
+{
+    Block& block = _blocks[b];
+    const u32 next = block.nextPhys;
+    Block& nextBlock = _blocks[next];
+    block.size += nextBlock.size;
+    block.nextPhys = nextBlock.nextPhys;
+    if(nextBlock.nextPhys != INVALID)
+        _blocks[nextBlock.nextPhys].prevPhys = b;
+    recycleBlock(next);
+}
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <tl/int_types.hpp>
+
+namespace tw
+{
+
+// Two-Level Segregated Fit allocator of ranges inside [0, capacity)
+// It doesn't touch any memory, it only keeps track of the ranges, so it can manage GPU buffers and be tested without a GL context
+// Sizes and offsets are in bytes and get rounded up to multiples of the granularity
+class RangeAllocator
+{
+public:
+    static constexpr u32 INVALID = u32(-1);
+
+    struct Move {
+        u32 handle;
+        u32 srcOffset;
+        u32 dstOffset;
+        u32 size;
+    };
+
+    RangeAllocator() = default;
+    RangeAllocator(u32 capacity, u32 granularity = 16);
+
+    // returns a handle, or INVALID if there isn't a big enough free range
+    u32 alloc(u32 size);
+    void free(u32 handle);
+
+    u32 offset(u32 handle)const { return _blocks[handle].offset * _granularity; }
+    u32 size(u32 handle)const { return _blocks[handle].size * _granularity; }
+
+    // Slides allocated ranges towards the beginning so the free space ends up in one piece at the end
+    // Moves at most maxBytes (at least one range if there is something to move). Handles stay valid
+    // The moves are appended in the order they must be performed. Source and destination can overlap
+    u32 defragment(u32 maxBytes, std::vector<Move>& moves);
+
+    u32 capacity()const { return _capacity * _granularity; }
+    u32 granularity()const { return _granularity; }
+    u32 usedBytes()const { return (_capacity - _freeUnits) * _granularity; }
+    u32 freeBytes()const { return _freeUnits * _granularity; }
+    u32 largestFreeRange()const;
+    // 0 when all the free space is contiguous, close to 1 when it's scattered in small pieces
+    float fragmentation()const;
+
+private:
+    static constexpr u32 SL_BITS = 4;
+    static constexpr u32 SL_COUNT = 1 << SL_BITS;
+    static constexpr u32 FL_COUNT = 32 - SL_BITS + 1;
+
+    struct Block {
+        u32 offset, size; // in units of granularity
+        u32 prevPhys, nextPhys;
+        u32 prevFree, nextFree;
+        bool isFree;
+    };
+
+    u32 newBlock();
+    void recycleBlock(u32 b);
+    void insertFree(u32 b);
+    void removeFree(u32 b);
+    u32 findFree(u32 units)const;
+    // merges b with the following physical block, which gets recycled
+    void absorbNext(u32 b);
+
+    std::vector<Block> _blocks;
+    u32 _unusedBlocks = INVALID;
+    u32 _firstBlock = INVALID;
+    u32 _capacity = 0;
+    u32 _granularity = 1;
+    u32 _freeUnits = 0;
+    u32 _flBitmap = 0;
+    u32 _slBitmaps[FL_COUNT] = {};
+    u32 _freeHeads[FL_COUNT][SL_COUNT];
+};
+
+}
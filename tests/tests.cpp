@@ -7,11 +7,17 @@ constexpr int size(const T(&)[N]) { return N; }
 void launch_test_0();
 void launch_test_1();
 void launch_test_2();
+void launch_test_3();
+void launch_test_4();
+void launch_test_5();
 
 static void (*exampleFns[])() = {
     launch_test_0,
     launch_test_1,
     launch_test_2,
+    launch_test_3,
+    launch_test_4,
+    launch_test_5,
 };
 
 constexpr int numTests = size(exampleFns);
@@ -20,6 +26,9 @@ static const char* testNames[] = {
     "triangle",
     "spinning_cube",
     "mesh_viewer",
+    "frame_pipeline",
+    "buffer_arena",
+    "range_allocator",
 };
 static_assert(size(testNames) == numTests);
 
@@ -0,0 +1,147 @@
+#include "vertex_layout.hpp"
+#include <stdio.h>
+#include <string.h>
+
+namespace tw
+{
+
+std::string injectVertexInputs(const char* vertShaderSrc, const VertexAttrib* attribs, u32 numAttribs)
+{
+    std::string src = vertShaderSrc;
+    // the declarations go after the #version and #extension lines at the top, which must come before any code
+    // blank lines and comments in between are skipped
+    size_t insertPos = 0;
+    size_t pos = 0;
+    while(pos < src.size())
+    {
+        pos = src.find_first_not_of(" \t\r\n", pos);
+        if(pos == std::string::npos)
+            break;
+        size_t end;
+        if(src.compare(pos, 2, "/*") == 0) {
+            end = src.find("*/", pos + 2);
+            end = end == std::string::npos ? src.size() : end + 2;
+        }
+        else {
+            end = src.find('\n', pos);
+            end = end == std::string::npos ? src.size() : end + 1;
+            const bool isDirective = src.compare(pos, 8, "#version") == 0 || src.compare(pos, 10, "#extension") == 0;
+            if(isDirective)
+                insertPos = end;
+            else if(src.compare(pos, 2, "//") != 0)
+                break;
+        }
+        pos = end;
+    }
+
+    std::string decls;
+    if(insertPos > 0 && src[insertPos - 1] != '\n')
+        decls += '\n';
+    char line[256];
+    for(u32 i = 0; i < numAttribs; i++) {
+        snprintf(line, sizeof(line), "layout(location = %u) in %s %s;\n", i, attribs[i].glslType, attribs[i].name);
+        decls += line;
+    }
+    src.insert(insertPos, decls);
+    return src;
+}
+
+// the type that glGetActiveAttrib reports for the GLSL input of an attribute
+static GLenum expectedGlslType(const VertexAttrib& attrib)
+{
+    static const GLenum floatTypes[] = {GL_FLOAT, GL_FLOAT_VEC2, GL_FLOAT_VEC3, GL_FLOAT_VEC4};
+    static const GLenum intTypes[] = {GL_INT, GL_INT_VEC2, GL_INT_VEC3, GL_INT_VEC4};
+    static const GLenum uintTypes[] = {GL_UNSIGNED_INT, GL_UNSIGNED_INT_VEC2, GL_UNSIGNED_INT_VEC3, GL_UNSIGNED_INT_VEC4};
+    const int i = attrib.numComponents - 1;
+    if(!attrib.integer)
+        return floatTypes[i];
+    return attrib.glType == GL_UNSIGNED_INT ? uintTypes[i] : intTypes[i];
+}
+
+bool validateVertexLayout(GLuint program, const VertexAttrib* attribs, u32 numAttribs)
+{
+    bool ok = true;
+    GLint numActive = 0;
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &numActive);
+    for(GLint a = 0; a < numActive; a++)
+    {
+        char name[128];
+        GLint arraySize;
+        GLenum type;
+        glGetActiveAttrib(program, a, sizeof(name), nullptr, &arraySize, &type, name);
+        if(strncmp(name, "gl_", 3) == 0)
+            continue;
+
+        u32 i = 0;
+        while(i < numAttribs && strcmp(attribs[i].name, name) != 0)
+            i++;
+        if(i == numAttribs) {
+            fprintf(stderr, "vertex layout: the shader input \"%s\" is not in the layout\n", name);
+            ok = false;
+            continue;
+        }
+        const GLint location = glGetAttribLocation(program, name);
+        if(location != (GLint)i) {
+            fprintf(stderr, "vertex layout: \"%s\" is at location %d in the shader but %u in the layout\n", name, location, i);
+            ok = false;
+        }
+        if(type != expectedGlslType(attribs[i])) {
+            fprintf(stderr, "vertex layout: \"%s\" is declared in the shader with a different type than %s\n", name, attribs[i].glslType);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static GLuint compileShader(GLenum type, const char* src)
+{
+    const GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &src, nullptr);
+    glCompileShader(shader);
+    GLint ok;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if(!ok) {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        fprintf(stderr, "Error compiling %s shader:\n%s\n", type == GL_VERTEX_SHADER ? "vertex" : "fragment", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint createShaderProgram(const char* vertShaderSrc, const char* fragShaderSrc, const VertexAttrib* attribs, u32 numAttribs)
+{
+    const std::string src = injectVertexInputs(vertShaderSrc, attribs, numAttribs);
+    const GLuint vertShader = compileShader(GL_VERTEX_SHADER, src.c_str());
+    const GLuint fragShader = compileShader(GL_FRAGMENT_SHADER, fragShaderSrc);
+    if(vertShader == 0 || fragShader == 0) {
+        glDeleteShader(vertShader);
+        glDeleteShader(fragShader);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertShader);
+    glAttachShader(program, fragShader);
+    glLinkProgram(program);
+    glDeleteShader(vertShader);
+    glDeleteShader(fragShader);
+    GLint ok;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if(!ok) {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        fprintf(stderr, "Error linking shader program:\n%s\n", log);
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    if(!validateVertexLayout(program, attribs, numAttribs)) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <stddef.h>
+#include <string>
+#include <utility>
+#include <iterator>
+#include <glad/glad.h>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <tl/int_types.hpp>
+
+// Describe the vertex struct once and get the attribute pointers and the GLSL inputs generated from it:
+//
+//   struct Vert { glm::vec3 pos; glm::u8vec4 color; };
+//   TW_VERTEX_LAYOUT(Vert,
+//       TW_VERTEX_ATTRIB(Vert, pos, "a_pos"),
+//       TW_VERTEX_ATTRIB(Vert, color, "a_color")
+//   )
+//
+//   tw::linkVertexLayout<Vert>(); // with the VAO and the VBO bound
+//   GLuint shader = tw::createShaderProgram<Vert>(vertShaderSrc, fragShaderSrc); // vertShaderSrc doesn't declare the inputs
+//
+// The location of each attribute is its position in the layout
+
+#define TW_VERTEX_ATTRIB(VERT, MEMBER, NAME) \
+    tw::makeVertexAttrib<decltype(VERT::MEMBER)>(NAME, offsetof(VERT, MEMBER))
+
+// must be used in the global namespace
+#define TW_VERTEX_LAYOUT(VERT, ...) \
+    namespace tw { \
+        template <> struct VertexLayout<VERT> { \
+            static constexpr VertexAttrib attribs[] = { __VA_ARGS__ }; \
+        }; \
+    }
+
+namespace tw
+{
+
+struct VertexAttrib
+{
+    const char* name;
+    u32 offset;
+    u32 size; // in bytes
+    GLint numComponents;
+    GLenum glType;
+    bool normalized;
+    bool integer;
+    const char* glslType;
+};
+
+template <typename T>
+struct VertexAttribTraits; // specialized below for each supported attribute type
+
+template <typename Vert>
+struct VertexLayout; // specialized with TW_VERTEX_LAYOUT
+
+template <typename T>
+constexpr VertexAttrib makeVertexAttrib(const char* name, size_t offset)
+{
+    using Traits = VertexAttribTraits<T>;
+    return {name, (u32)offset, Traits::size, Traits::numComponents, Traits::glType, Traits::normalized, Traits::integer, Traits::glslType};
+}
+
+template <typename Vert>
+constexpr u32 numVertexAttribs() { return (u32)std::size(VertexLayout<Vert>::attribs); }
+
+// Emits the glVertexAttribPointer calls of the layout, all the arguments are compile time constants
+// The VAO and the ARRAY_BUFFER must be bound. baseOffset is the offset of the first vertex in the buffer
+template <typename Vert>
+void linkVertexLayout(size_t baseOffset = 0);
+
+// inserts the "layout(location = N) in TYPE NAME;" declarations after the leading #version and #extension lines
+std::string injectVertexInputs(const char* vertShaderSrc, const VertexAttrib* attribs, u32 numAttribs);
+
+// checks the active attributes of the program against the layout: same locations and types
+// prints the mismatches to stderr
+bool validateVertexLayout(GLuint program, const VertexAttrib* attribs, u32 numAttribs);
+
+// Compiles and links the program with the inputs of the layout injected in the vertex shader
+// Returns 0 if it fails to compile or link, or if the linked program doesn't match the layout
+GLuint createShaderProgram(const char* vertShaderSrc, const char* fragShaderSrc, const VertexAttrib* attribs, u32 numAttribs);
+template <typename Vert>
+GLuint createShaderProgram(const char* vertShaderSrc, const char* fragShaderSrc);
+
+// --- IMPL ---
+
+#define TW_VERTEX_ATTRIB_TRAITS(T, NUM_COMPONENTS, GL_TYPE, NORMALIZED, INTEGER, GLSL_TYPE) \
+    template <> struct VertexAttribTraits<T> { \
+        static constexpr u32 size = sizeof(T); \
+        static constexpr GLint numComponents = NUM_COMPONENTS; \
+        static constexpr GLenum glType = GL_TYPE; \
+        static constexpr bool normalized = NORMALIZED; \
+        static constexpr bool integer = INTEGER; \
+        static constexpr const char* glslType = GLSL_TYPE; \
+    };
+
+TW_VERTEX_ATTRIB_TRAITS(float, 1, GL_FLOAT, false, false, "float")
+TW_VERTEX_ATTRIB_TRAITS(glm::vec2, 2, GL_FLOAT, false, false, "vec2")
+TW_VERTEX_ATTRIB_TRAITS(glm::vec3, 3, GL_FLOAT, false, false, "vec3")
+TW_VERTEX_ATTRIB_TRAITS(glm::vec4, 4, GL_FLOAT, false, false, "vec4")
+TW_VERTEX_ATTRIB_TRAITS(glm::u8vec4, 4, GL_UNSIGNED_BYTE, true, false, "vec4")
+TW_VERTEX_ATTRIB_TRAITS(glm::u16vec2, 2, GL_UNSIGNED_SHORT, true, false, "vec2")
+TW_VERTEX_ATTRIB_TRAITS(i32, 1, GL_INT, false, true, "int")
+TW_VERTEX_ATTRIB_TRAITS(glm::ivec4, 4, GL_INT, false, true, "ivec4")
+TW_VERTEX_ATTRIB_TRAITS(u32, 1, GL_UNSIGNED_INT, false, true, "uint")
+TW_VERTEX_ATTRIB_TRAITS(glm::uvec4, 4, GL_UNSIGNED_INT, false, true, "uvec4")
+
+#undef TW_VERTEX_ATTRIB_TRAITS
+
+template <typename Vert, u32 I>
+inline void linkVertexAttrib(size_t baseOffset)
+{
+    constexpr VertexAttrib attrib = VertexLayout<Vert>::attribs[I];
+    static_assert(attrib.offset + attrib.size <= sizeof(Vert), "vertex attribute outside of the vertex struct");
+    glEnableVertexAttribArray(I);
+    if constexpr(attrib.integer)
+        glVertexAttribIPointer(I, attrib.numComponents, attrib.glType, sizeof(Vert), (void*)(baseOffset + attrib.offset));
+    else
+        glVertexAttribPointer(I, attrib.numComponents, attrib.glType, attrib.normalized ? GL_TRUE : GL_FALSE, sizeof(Vert), (void*)(baseOffset + attrib.offset));
+}
+
+template <typename Vert, u32... I>
+inline void linkVertexLayout(size_t baseOffset, std::integer_sequence<u32, I...>)
+{
+    (linkVertexAttrib<Vert, I>(baseOffset), ...);
+}
+
+template <typename Vert>
+void linkVertexLayout(size_t baseOffset)
+{
+    linkVertexLayout<Vert>(baseOffset, std::make_integer_sequence<u32, numVertexAttribs<Vert>()>());
+}
+
+template <typename Vert>
+GLuint createShaderProgram(const char* vertShaderSrc, const char* fragShaderSrc)
+{
+    return createShaderProgram(vertShaderSrc, fragShaderSrc, VertexLayout<Vert>::attribs, numVertexAttribs<Vert>());
+}
+
+}